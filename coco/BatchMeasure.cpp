@@ -0,0 +1,105 @@
+#include "BatchMeasure.hpp"
+#include <cstring>
+
+
+namespace coco {
+
+// number of texts that a thread takes at once
+constexpr int CHUNK_SIZE = 256;
+
+BatchMeasure::BatchMeasure(int threadCount) {
+    if (threadCount <= 0)
+        threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+
+    // the calling thread is thread 0
+    for (int i = 1; i < threadCount; ++i)
+        this->threads.emplace_back(&BatchMeasure::worker, this, i);
+}
+
+BatchMeasure::~BatchMeasure() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stop = true;
+    }
+    this->start.notify_all();
+    for (auto &thread : this->threads)
+        thread.join();
+}
+
+bool BatchMeasure::isAscii(String text) {
+    auto d = (const uint8_t *)text.data();
+    int len = text.size();
+    int i = 0;
+
+    // check blocks of 8 characters
+    for (; i + 8 <= len; i += 8) {
+        uint64_t block;
+        std::memcpy(&block, d + i, 8);
+        if (block & 0x8080808080808080)
+            return false;
+    }
+    for (; i < len; ++i) {
+        if (d[i] & 0x80)
+            return false;
+    }
+    return true;
+}
+
+void BatchMeasure::run(int count, const Job &job) {
+    // small jobs are done on the calling thread
+    if (count <= CHUNK_SIZE || this->threads.empty()) {
+        if (count > 0)
+            job(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard lock(this->mutex);
+        this->job = &job;
+        this->count = count;
+        this->next = 0;
+        this->active = int(this->threads.size());
+        ++this->generation;
+    }
+    this->start.notify_all();
+
+    // calling thread works too
+    work(0);
+
+    // wait until all workers are finished
+    std::unique_lock lock(this->mutex);
+    this->done.wait(lock, [this] {return this->active == 0;});
+    this->job = nullptr;
+}
+
+void BatchMeasure::work(int thread) {
+    while (true) {
+        int begin = this->next.fetch_add(CHUNK_SIZE);
+        if (begin >= this->count)
+            break;
+        (*this->job)(begin, std::min(begin + CHUNK_SIZE, this->count), thread);
+    }
+}
+
+void BatchMeasure::worker(int thread) {
+    int generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(this->mutex);
+            this->start.wait(lock, [this, generation] {return this->stop || this->generation != generation;});
+            if (this->stop)
+                return;
+            generation = this->generation;
+        }
+
+        work(thread);
+
+        {
+            std::lock_guard lock(this->mutex);
+            if (--this->active == 0)
+                this->done.notify_one();
+        }
+    }
+}
+
+} // namespace coco
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Font.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace coco {
+
+/// @brief Measures the widths of many strings in parallel on a pool of threads, e.g. to size the columns of a table.
+/// Only available on platforms with threads (Windows, MacOS, Linux)
+class BatchMeasure {
+public:
+    /// @brief Constructor
+    /// @param threadCount Number of threads including the calling thread, 0 for the number of hardware threads
+    explicit BatchMeasure(int threadCount = 0);
+    ~BatchMeasure();
+
+    BatchMeasure(const BatchMeasure &) = delete;
+    BatchMeasure &operator =(const BatchMeasure &) = delete;
+
+    /// @brief Get number of threads including the calling thread
+    /// @return Number of threads
+    int threadCount() const {return int(this->threads.size()) + 1;}
+
+    /// @brief Calculate the widths of the given texts, the results are identical to font.calcWidth(text)
+    /// @param font Font
+    /// @param texts Texts to measure, row by row if columnCount is greater than 1
+    /// @param widths Resulting widths, must have the same size as texts
+    /// @param columnCount Number of columns of the table, must be at least 1
+    /// @return Maximum width of each column, empty if columnCount is less than 1 or the size of widths is wrong
+    template <typename F>
+    std::vector<int> calcWidths(const F &font, std::span<const String> texts, std::span<int> widths,
+        int columnCount = 1)
+    {
+        if (columnCount < 1 || widths.size() != texts.size())
+            return {};
+
+        // ASCII fast path for fonts with glyph lookup: table of glyph widths including gap (glyphs are single
+        // code points, therefore the sum over an ASCII text is the same as calcWidth())
+        int ascii[128];
+        bool fast = false;
+        if constexpr (requires {font.begin;}) {
+            for (int i = 0; i < 128; ++i) {
+                char ch = char(i);
+                ascii[i] = font.calcWidth(String(&ch, 1));
+            }
+            fast = true;
+        }
+
+        // per-thread scratch space for the column maxima, each thread uses its own cache lines
+        int stride = (columnCount + CacheLine::SIZE - 1) / CacheLine::SIZE;
+        this->scratch.assign(threadCount() * stride, CacheLine{});
+        auto maximum = [this, stride](int thread, int column) -> int & {
+            return this->scratch[thread * stride + column / CacheLine::SIZE].values[column % CacheLine::SIZE];
+        };
+
+        run(int(texts.size()), [&](int begin, int end, int thread) {
+            for (int i = begin; i < end; ++i) {
+                String text = texts[i];
+                int width;
+                if (fast && isAscii(text)) {
+                    width = 0;
+                    auto d = (const uint8_t *)text.data();
+                    for (int j = 0; j < text.size(); ++j)
+                        width += ascii[d[j]];
+                } else {
+                    width = font.calcWidth(text);
+                }
+                widths[i] = width;
+                int &m = maximum(thread, i % columnCount);
+                m = std::max(m, width);
+            }
+        });
+
+        // merge column maxima of all threads
+        std::vector<int> columnWidths(columnCount, 0);
+        for (int t = 0; t < threadCount(); ++t) {
+            for (int c = 0; c < columnCount; ++c)
+                columnWidths[c] = std::max(columnWidths[c], maximum(t, c));
+        }
+        return columnWidths;
+    }
+
+protected:
+    using Job = std::function<void (int begin, int end, int thread)>;
+
+    // check if a text consists of ASCII characters only
+    static bool isAscii(String text);
+
+    // run a job for count items, split into chunks that are distributed over all threads
+    void run(int count, const Job &job);
+
+    // process chunks of the current job
+    void work(int thread);
+
+    // worker thread
+    void worker(int thread);
+
+    // cache line of scratch space, aligned so that threads never share a cache line
+    struct alignas(64) CacheLine {
+        static constexpr int SIZE = 64 / sizeof(int);
+        int values[SIZE];
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<CacheLine> scratch;
+
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+
+    // current job
+    const Job *job = nullptr;
+    int count = 0;
+    std::atomic<int> next;
+
+    // generation of current job, used to wake up the workers
+    int generation = 0;
+
+    // number of workers that are still working on the current job
+    int active = 0;
+
+    bool stop = false;
+};
+
+} // namespace coco
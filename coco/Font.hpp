@@ -3,7 +3,9 @@
 #include <coco/convert.hpp>
 #include <coco/String.hpp>
 #include <coco/Vector2.hpp>
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
 #ifdef NATIVE
 #include <ostream>
 #endif
@@ -58,6 +60,68 @@ int startsWith(const String &s, const GlyphInfo &info);
 /// @return String without first UTF-8 character
 //String removeFirstUtf8(String s);
 
+/// @brief Decode one UTF-8 character and advance the pointer by its length (at least 1).
+/// In contrast to utf8() from coco/convert.hpp this works on raw pointers without constructing a String for each
+/// character and defines how invalid input is split by the glyph ranges of all font types: each invalid byte
+/// (including truncated and overlong sequences) is one character with code -1, which gets the placeholder glyph
+/// @param it Pointer to current character, gets advanced to next character
+/// @param end End of text
+/// @return Code point or -1 if the character is not valid UTF-8
+inline int decodeUtf8(const uint8_t *&it, const uint8_t *end) {
+    // https://en.wikipedia.org/wiki/UTF-8
+    int code = *it;
+    ++it;
+    if (code <= 0x7F)
+        return code;
+    int length;
+    if (code >= 0xC0 && code <= 0xDF) {
+        code &= 0x1F;
+        length = 1;
+    } else if (code >= 0xE0 && code <= 0xEF) {
+        code &= 0x0F;
+        length = 2;
+    } else if (code >= 0xF0 && code <= 0xF7) {
+        code &= 0x07;
+        length = 3;
+    } else {
+        // invalid lead byte
+        return -1;
+    }
+    if (end - it < length)
+        return -1;
+    for (int i = 0; i < length; ++i) {
+        int c = it[i];
+        if ((c & 0xC0) != 0x80)
+            return -1;
+        code = (code << 6) | (c & 0x3F);
+    }
+
+    // reject overlong encoding
+    if (code < (length == 1 ? 0x80 : length == 2 ? 0x800 : 0x10000))
+        return -1;
+    it += length;
+    return code;
+}
+
+/// @brief Count UTF-8 characters in the same way as decodeUtf8() splits the text, i.e. each invalid byte counts
+/// as one character
+/// @param text Text
+/// @return Number of characters
+inline int countUtf8(String text) {
+    auto it = (const uint8_t*)text.data();
+    auto end = it + text.size();
+    int count = 0;
+    while (it < end) {
+        // fast path for ASCII characters
+        if (*it <= 0x7F)
+            ++it;
+        else
+            decodeUtf8(it, end);
+        ++count;
+    }
+    return count;
+}
+
 
 struct LinearFontTraits {
     using LocationType = int;
@@ -75,6 +139,19 @@ struct TextureFontTraits {
     }
 };
 
+/// @brief Traits for a monospace font where all glyphs have the same size and are stored linearly
+/// @tparam W Glyph width
+/// @tparam H Glyph height
+/// @tparam S Stride (size of one glyph in the bitmap data), e.g. W * H for 8 bit per pixel
+template <int W, int H, int S>
+struct MonospaceFontTraits {
+    using LocationType = int;
+
+    static constexpr int width = W;
+    static constexpr int height = H;
+    static constexpr int stride = S;
+};
+
 
 /// @brief Font
 /// @tparam T Font traits
@@ -122,46 +199,59 @@ struct Font {
 
 
     struct GlyphRange {
-        const Font &font;
-        String text;
+        const Font *font;
+
+        // text
+        const uint8_t *textBegin;
+        const uint8_t *textEnd;
 
+        /// @brief Trivially copyable forward iterator that decodes the text between raw pointers
+        ///
         struct Iterator {
-            const Font<T> &font;
-            String text;
+            using value_type = Glyph;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+
+            const Font *font;
+
+            // current and next character
+            const uint8_t *current;
+            const uint8_t *next;
+            const uint8_t *end;
+
+            // glyph of current character
             const GlyphInfo *info;
 
             Iterator &operator ++() {
-                if (this->text.size() > 0) {
-                    auto begin = this->font.begin + 2;
-                    //Font::Less less;
-                    auto info = std::upper_bound(begin, this->font.end, this->text);//, less);
-                    --info;
-
-                    int l = startsWith(this->text, *info);
-                    if (l) {
-                        // found character sequence
-                        this->info = info;
-                    } else {
-                        // unknown character, use placeholder (first glyph)
-                        this->info = this->font.begin;
-
-                        // get length of first utf-8 character
-                        l = std::max(utf8(this->text).length, 1);
-                    }
-
-                    // remove character sequence
-                    this->text = this->text.substring(l);
-                } else {
-                    this->info = nullptr;
+                this->current = this->next;
+                if (this->current < this->end) {
+                    // search glyph by code, the first glyph is the placeholder for unknown characters
+                    int code = decodeUtf8(this->next, this->end);
+                    auto begin = this->font->begin + 1;
+                    auto end = this->font->end;
+                    auto info = std::lower_bound(begin, end, code);
+                    this->info = info < end && info->code() == code ? info : this->font->begin;
                 }
                 return *this;
             }
 
+            Iterator operator ++(int) {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+
             bool operator ==(const Iterator &it) const {
-                return this->info == it.info;
+                return this->current == it.current;
+            }
+
+            /// @brief Get number of bytes of the text that follow the current glyph
+            /// @return Number of remaining bytes
+            int remaining() const {
+                return int(this->end - this->next);
             }
 
-            Glyph operator *() {
+            Glyph operator *() const {
                 auto data1 = this->info->data1;
                 auto data2 = this->info->data2;
                 return {
@@ -172,14 +262,14 @@ struct Font {
             }
         };
 
-        Iterator begin() {
-            Iterator it{this->font, text};
+        Iterator begin() const {
+            Iterator it{this->font, this->textBegin, this->textBegin, this->textEnd, this->font->begin};
             ++it;
             return it;
         }
 
-        Iterator end() {
-            return {this->font, String(), nullptr};
+        Iterator end() const {
+            return {this->font, this->textEnd, this->textEnd, this->textEnd, nullptr};
         }
     };
 
@@ -194,7 +284,10 @@ struct Font {
     /// }
     /// @param text Text to get glyphs for
     /// @return GlyphRange object that can be used in range-based for loop
-    GlyphRange glyphRange(String text) const {return {*this, text};}
+    GlyphRange glyphRange(String text) const {
+        auto data = (const uint8_t*)text.data();
+        return {this, data, data + text.size()};
+    }
 
 
 
@@ -236,8 +329,150 @@ struct Font {
     }
 };
 
+/// @brief Monospace font with a dense code range where the glyph location is calculated from the code.
+/// The bitmap data starts with the placeholder glyph for unknown characters, followed by the glyphs for
+/// firstCode to firstCode + count - 1. Glyph size and stride are compile time constants
+/// @tparam W Glyph width
+/// @tparam H Glyph height
+/// @tparam S Stride (size of one glyph in the bitmap data)
+template <int W, int H, int S>
+struct Font<MonospaceFontTraits<W, H, S>> {
+    // size of glyph
+    static constexpr int2 size = {W, H};
+
+    // overall character height
+    static constexpr int height = H;
+
+    // size of gap between characters
+    uint8_t gapWidth;
+
+    // glyph bitmap data (placeholder glyph followed by count glyphs)
+    const uint8_t *data;
+
+    // code of first glyph
+    int firstCode;
+
+    // number of glyphs (excluding the placeholder)
+    int count;
+
+
+    struct Glyph {
+        // size of glyph
+        int2 size;
+
+        // y-position of glyph
+        int y;
+
+        // location in linear data
+        int location;
+    };
+
+    /// @brief Get location of the glyph for a code
+    /// @param code Code point
+    /// @return Location in the bitmap data, 0 (placeholder) if the code is not in the font
+    int getLocation(int code) const {
+        unsigned index = unsigned(code - this->firstCode);
+        return index < unsigned(this->count) ? int(index + 1) * S : 0;
+    }
+
+    struct GlyphRange {
+        const Font *font;
+
+        // text
+        const uint8_t *textBegin;
+        const uint8_t *textEnd;
+
+        struct Iterator {
+            using value_type = Glyph;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+
+            const Font *font;
+
+            // current and next character
+            const uint8_t *current;
+            const uint8_t *next;
+            const uint8_t *end;
+
+            // location of current glyph
+            int location;
+
+            Iterator &operator ++() {
+                this->current = this->next;
+                if (this->current < this->end)
+                    this->location = this->font->getLocation(decodeUtf8(this->next, this->end));
+                return *this;
+            }
+
+            Iterator operator ++(int) {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+
+            bool operator ==(const Iterator &it) const {
+                return this->current == it.current;
+            }
+
+            /// @brief Get number of bytes of the text that follow the current glyph
+            /// @return Number of remaining bytes
+            int remaining() const {
+                return int(this->end - this->next);
+            }
+
+            Glyph operator *() const {
+                return {{W, H}, 0, this->location};
+            }
+        };
+
+        Iterator begin() const {
+            Iterator it{this->font, this->textBegin, this->textBegin, this->textEnd, 0};
+            ++it;
+            return it;
+        }
+
+        Iterator end() const {
+            return {this->font, this->textEnd, this->textEnd, this->textEnd, 0};
+        }
+    };
+
+    /// @brief Get glyph range for text that can be used to iterate over glyphs in range-based for loop
+    /// @param text Text to get glyphs for
+    /// @return GlyphRange object that can be used in range-based for loop
+    GlyphRange glyphRange(String text) const {
+        auto data = (const uint8_t*)text.data();
+        return {this, data, data + text.size()};
+    }
+
+    int calcWidth(String text) const {
+        return countUtf8(text) * (W + this->gapWidth);
+    }
+
+    /// @brief Return the next code provided by the font.
+    /// @param code Code
+    /// @return Next code or first code if the last code was given, -1 if the font contains no glyphs
+    int nextCode(int code) const {
+        if (this->count <= 0)
+            return -1;
+        int last = this->firstCode + this->count - 1;
+        return code >= this->firstCode && code < last ? code + 1 : this->firstCode;
+    }
+
+    /// @brief Return the previous code provided by the font.
+    /// @param code Code
+    /// @return Previous code or last code if the first code was given, -1 if the font contains no glyphs
+    int prevCode(int code) const {
+        if (this->count <= 0)
+            return -1;
+        int last = this->firstCode + this->count - 1;
+        return code > this->firstCode && code <= last ? code - 1 : last;
+    }
+};
+
 using LinearFont = Font<LinearFontTraits>;
 using TextureFont = Font<TextureFontTraits>;
+template <int W, int H, int S>
+using MonospaceFont = Font<MonospaceFontTraits<W, H, S>>;
 
 
 /*
@@ -0,0 +1,138 @@
+#include "FontCoverage.hpp"
+#include <bit>
+#include <cstring>
+
+
+namespace coco {
+
+void FontCoverage::clear() {
+    std::memset(this->pages[0], 0, sizeof(Page));
+    std::memset(this->index, 0, sizeof(this->index));
+    this->count = 0;
+}
+
+bool FontCoverage::add(int code) {
+    if (unsigned(code) >= unsigned(PAGE_COUNT * PAGE_SIZE))
+        return false;
+    int p = this->index[code >> 10];
+    if (p == 0) {
+        // allocate a new page
+        if (this->count >= this->capacity)
+            return false;
+        p = ++this->count;
+        std::memset(this->pages[p], 0, sizeof(Page));
+        this->index[code >> 10] = p;
+    }
+    this->pages[p][(code >> 5) & (PAGE_WORDS - 1)] |= uint32_t(1) << (code & 31);
+    return true;
+}
+
+bool FontCoverage::add(const GlyphInfo *begin, const GlyphInfo *end) {
+    bool result = true;
+    for (auto info = begin; info < end; ++info) {
+        if (!info->extended())
+            result &= add(info->code());
+    }
+    return result;
+}
+
+bool FontCoverage::coversAll(String text) const {
+    auto d = (const uint8_t*)text.data();
+    auto e = d + text.size();
+
+    // bitmap of ASCII codes
+    auto &ascii = this->pages[this->index[0]];
+
+    while (d < e) {
+        // fast path: check blocks of 8 ASCII characters
+        while (e - d >= 8) {
+            uint64_t block;
+            std::memcpy(&block, d, 8);
+            if (block & 0x8080808080808080)
+                break;
+            uint32_t missing = 0;
+            for (int i = 0; i < 8; ++i) {
+                int c = d[i];
+                missing |= ~(ascii[c >> 5] >> (c & 31)) & 1;
+            }
+            if (missing)
+                return false;
+            d += 8;
+        }
+        if (d >= e)
+            break;
+
+        // decode one UTF-8 character (invalid characters return -1 which is not covered)
+        if (!covers(decodeUtf8(d, e)))
+            return false;
+    }
+    return true;
+}
+
+int FontCoverage::findForward(int code) const {
+    int pageIndex = code >> 10;
+    int wordIndex = (code >> 5) & (PAGE_WORDS - 1);
+    uint32_t mask = ~uint32_t(0) << (code & 31);
+    while (pageIndex < PAGE_COUNT) {
+        int p = this->index[pageIndex];
+        if (p != 0) {
+            auto &page = this->pages[p];
+            for (; wordIndex < PAGE_WORDS; ++wordIndex) {
+                uint32_t word = page[wordIndex] & mask;
+                if (word != 0)
+                    return (pageIndex << 10) | (wordIndex << 5) | std::countr_zero(word);
+                mask = ~uint32_t(0);
+            }
+        }
+
+        // skip to next page
+        ++pageIndex;
+        wordIndex = 0;
+        mask = ~uint32_t(0);
+    }
+    return -1;
+}
+
+int FontCoverage::findBackward(int code) const {
+    int pageIndex = code >> 10;
+    int wordIndex = (code >> 5) & (PAGE_WORDS - 1);
+    uint32_t mask = ~uint32_t(0) >> (31 - (code & 31));
+    while (pageIndex >= 0) {
+        int p = this->index[pageIndex];
+        if (p != 0) {
+            auto &page = this->pages[p];
+            for (; wordIndex >= 0; --wordIndex) {
+                uint32_t word = page[wordIndex] & mask;
+                if (word != 0)
+                    return (pageIndex << 10) | (wordIndex << 5) | (31 - std::countl_zero(word));
+                mask = ~uint32_t(0);
+            }
+        }
+
+        // skip to previous page
+        --pageIndex;
+        wordIndex = PAGE_WORDS - 1;
+        mask = ~uint32_t(0);
+    }
+    return -1;
+}
+
+int FontCoverage::next(int code) const {
+    if (code < -1)
+        code = -1;
+    int n = code + 1 < PAGE_COUNT * PAGE_SIZE ? findForward(code + 1) : -1;
+
+    // wrap around to first code
+    return n >= 0 ? n : findForward(0);
+}
+
+int FontCoverage::prev(int code) const {
+    if (code > PAGE_COUNT * PAGE_SIZE)
+        code = PAGE_COUNT * PAGE_SIZE;
+    int p = code > 0 ? findBackward(code - 1) : -1;
+
+    // wrap around to last code
+    return p >= 0 ? p : findBackward(PAGE_COUNT * PAGE_SIZE - 1);
+}
+
+} // namespace coco
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Font.hpp"
+#include <coco/String.hpp>
+#include <cstdint>
+
+
+namespace coco {
+
+/// @brief Coverage bitmap of a font for fast "does the font contain this code" queries.
+/// The 18 bit code space is split into 256 pages of 1024 codes. A page index maps each page to a 1024 bit page
+/// bitmap where all pages without any code share the empty page 0. The page storage is provided by FontCoverageBuffer.
+class FontCoverage {
+public:
+    // number of codes per page
+    static constexpr int PAGE_SIZE = 1024;
+
+    // number of 32 bit words per page
+    static constexpr int PAGE_WORDS = PAGE_SIZE / 32;
+
+    // number of pages in the 18 bit code space
+    static constexpr int PAGE_COUNT = 0x40000 / PAGE_SIZE;
+
+    using Page = uint32_t[PAGE_WORDS];
+
+
+    FontCoverage(const FontCoverage &) = delete;
+    FontCoverage &operator =(const FontCoverage &) = delete;
+
+    /// @brief Remove all codes
+    ///
+    void clear();
+
+    /// @brief Add a code to the coverage
+    /// @param code Code point
+    /// @return true if successful, false if the code is out of range or no page is left
+    bool add(int code);
+
+    /// @brief Add all codes of a glyph list (e.g. font.begin + 1 to exclude the placeholder)
+    /// @param begin Begin of glyph list
+    /// @param end End of glyph list
+    /// @return true if successful, false if capacity was exceeded
+    bool add(const GlyphInfo *begin, const GlyphInfo *end);
+
+    /// @brief Build coverage from the glyphs of a font, excluding the placeholder
+    /// @param font Font
+    /// @return true if successful, false if capacity was exceeded
+    template <typename T>
+    bool build(const Font<T> &font) {
+        clear();
+        return add(font.begin + 1, font.end);
+    }
+
+    /// @brief Check if the given code is covered
+    /// @param code Code point
+    /// @return true if covered
+    bool covers(int code) const {
+        if (unsigned(code) >= unsigned(PAGE_COUNT * PAGE_SIZE))
+            return false;
+        auto &page = this->pages[this->index[code >> 10]];
+        return (page[(code >> 5) & (PAGE_WORDS - 1)] >> (code & 31)) & 1;
+    }
+
+    /// @brief Check if all UTF-8 characters of the given text are covered
+    /// @param text Text
+    /// @return true if all characters are covered, false if a character is not covered or the text is not valid UTF-8
+    bool coversAll(String text) const;
+
+    /// @brief Return the next covered code, same semantics as Font::nextCode()
+    /// @param code Code
+    /// @return Next code or first code if the last code was given, -1 if the coverage is empty
+    int next(int code) const;
+
+    /// @brief Return the previous covered code, same semantics as Font::prevCode()
+    /// @param code Code
+    /// @return Previous code or last code if the first code was given, -1 if the coverage is empty
+    int prev(int code) const;
+
+    /// @brief Get number of allocated pages (excluding the shared empty page)
+    /// @return Number of pages
+    int pageCount() const {return this->count;}
+
+protected:
+    FontCoverage(Page *pages, int capacity) : pages(pages), capacity(capacity) {}
+
+    // find first covered code in [code, end of code space) or -1
+    int findForward(int code) const;
+
+    // find last covered code in [0, code] or -1
+    int findBackward(int code) const;
+
+    // page storage, pages[0] is the shared empty page
+    Page *pages;
+
+    // maximum number of pages (excluding the empty page)
+    int capacity;
+
+    // number of allocated pages
+    int count;
+
+    // page index for each 1024 code block, 0 is the empty page
+    uint8_t index[PAGE_COUNT];
+};
+
+/// @brief Font coverage with storage for N pages
+/// @tparam N Maximum number of non-empty pages (at most 255), e.g. 1 for a font that only covers codes < 1024
+template <int N>
+class FontCoverageBuffer : public FontCoverage {
+public:
+    static_assert(N >= 1 && N <= 255);
+
+    FontCoverageBuffer() : FontCoverage(buffer, N) {clear();}
+
+    template <typename T>
+    explicit FontCoverageBuffer(const Font<T> &font) : FontCoverage(buffer, N) {this->build(font);}
+
+protected:
+    Page buffer[N + 1];
+};
+
+} // namespace coco
@@ -0,0 +1,103 @@
+#include "FontOptimizer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <string>
+
+
+namespace coco {
+
+OptimizedFont::OptimizedFont(const LinearFont &font, int bitsPerPixel)
+    : gapWidth(font.gapWidth), height(font.height)
+{
+    assert(bitsPerPixel == 1 || bitsPerPixel == 2 || bitsPerPixel == 4 || bitsPerPixel == 8);
+    auto &r = this->r;
+    r.glyphCount = int(font.end - font.begin);
+    r.dataSizeBefore = font.dataSize;
+
+    // map from glyph bitmap (including size) to location in the optimized data
+    std::map<std::string, int> locations;
+
+    for (auto info = font.begin; info < font.end; ++info) {
+        uint32_t data1 = info->data1;
+        uint32_t data2 = info->data2;
+        int width = (data1 >> 18) & 0x7f;
+        int height = data1 >> 25;
+        int location = data2 & 0xffffff;
+        int y = (data2 >> 24) & 0x7f;
+        int rowSize = (width * bitsPerPixel + 7) / 8;
+        r.glyphBytesBefore += rowSize * height;
+
+        // find first and last row that contain ink
+        auto bitmap = font.data + location;
+        auto blank = [bitmap, rowSize](int row) {
+            auto d = bitmap + row * rowSize;
+            for (int i = 0; i < rowSize; ++i) {
+                if (d[i] != 0)
+                    return false;
+            }
+            return true;
+        };
+        int top = 0;
+        while (top < height && blank(top))
+            ++top;
+        int bottom = height;
+        while (bottom > top && blank(bottom - 1))
+            --bottom;
+
+        int trimmedHeight = bottom - top;
+        if (trimmedHeight == 0) {
+            // glyph without ink (e.g. space)
+            y = 0;
+            location = 0;
+        } else {
+            // y is stored with 7 bit, keep blank rows at the top that y can not absorb
+            top = std::min(top, 0x7f - y);
+            trimmedHeight = bottom - top;
+            y += top;
+        }
+        if (trimmedHeight < height) {
+            ++r.trimmedGlyphCount;
+            r.trimmedRows += height - trimmedHeight;
+        }
+        if (trimmedHeight > 0) {
+            // key is size followed by the trimmed bitmap
+            int size = rowSize * trimmedHeight;
+            std::string key;
+            key += char(width);
+            key += char(trimmedHeight);
+            key.append((const char *)bitmap + top * rowSize, size);
+
+            auto it = locations.find(key);
+            if (it != locations.end()) {
+                // share existing bitmap
+                ++r.sharedGlyphCount;
+                location = it->second;
+            } else {
+                location = int(this->data.size());
+                this->data.insert(this->data.end(), bitmap + top * rowSize, bitmap + top * rowSize + size);
+                locations[key] = location;
+            }
+            r.glyphBytesAfter += size;
+        }
+
+        this->glyphs.push_back({
+            (data1 & 0x3ffff) | (width << 18) | (uint32_t(trimmedHeight) << 25),
+            uint32_t(location) | (y << 24) | (data2 & 0x80000000)
+        });
+    }
+    r.dataSizeAfter = int(this->data.size());
+}
+
+#ifdef NATIVE
+std::ostream &operator <<(std::ostream &s, const OptimizedFont::Report &r) {
+    s << "glyphs: " << r.glyphCount
+        << ", trimmed: " << r.trimmedGlyphCount << " (" << r.trimmedRows << " rows)"
+        << ", shared: " << r.sharedGlyphCount
+        << ", data: " << r.dataSizeBefore << " -> " << r.dataSizeAfter << " bytes"
+        << ", glyph bytes: " << r.glyphBytesBefore << " -> " << r.glyphBytesAfter;
+    return s;
+}
+#endif
+
+} // namespace coco
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Font.hpp"
+#include <vector>
+#ifdef NATIVE
+#include <ostream>
+#endif
+
+
+namespace coco {
+
+/// @brief Optimized copy of a linear font, intended for font converters running on the host.
+/// Each glyph is trimmed vertically to its ink bounding box by removing blank rows at the top and bottom and
+/// adjusting y and height, the width is kept because it is the advance width of the glyph.
+/// Glyphs with identical bitmaps share one location in the bitmap data.
+/// The bitmap of a glyph is expected to be stored row by row where each row is padded to full bytes, i.e. a row
+/// has (width * bitsPerPixel + 7) / 8 bytes and the padding bits are 0.
+/// Only available on platforms that are not cross compiled (Windows, MacOS, Linux)
+class OptimizedFont {
+public:
+    struct Report {
+        // number of glyphs including the placeholder
+        int glyphCount = 0;
+
+        // number of glyphs that had blank rows and total number of removed rows
+        int trimmedGlyphCount = 0;
+        int trimmedRows = 0;
+
+        // number of glyphs that share the bitmap of another glyph
+        int sharedGlyphCount = 0;
+
+        // size of bitmap data
+        int dataSizeBefore = 0;
+        int dataSizeAfter = 0;
+
+        // sum of bitmap sizes of all glyphs, i.e. bytes touched when rendering each glyph once
+        int glyphBytesBefore = 0;
+        int glyphBytesAfter = 0;
+    };
+
+    /// @brief Constructor
+    /// @param font Font to optimize
+    /// @param bitsPerPixel Bits per pixel of the bitmap data (1, 2, 4 or 8)
+    OptimizedFont(const LinearFont &font, int bitsPerPixel);
+
+    /// @brief Get the optimized font that references the glyphs and data of this object
+    /// @return Optimized font
+    LinearFont font() const {
+        return {this->gapWidth, this->height, this->data.data(), int(this->data.size()),
+            this->glyphs.data(), this->glyphs.data() + this->glyphs.size()};
+    }
+
+    const Report &report() const {return this->r;}
+
+    // optimized glyph list
+    std::vector<GlyphInfo> glyphs;
+
+    // optimized bitmap data
+    std::vector<uint8_t> data;
+
+protected:
+    uint8_t gapWidth;
+    uint8_t height;
+    Report r;
+};
+
+#ifdef NATIVE
+std::ostream &operator <<(std::ostream &s, const OptimizedFont::Report &r);
+#endif
+
+} // namespace coco
@@ -0,0 +1,196 @@
+#include "GlyphAtlas.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+
+namespace coco {
+
+// space between glyphs to prevent bleeding when the texture is sampled with filtering
+constexpr int PADDING = 1;
+
+GlyphAtlas::GlyphAtlas(const LinearFont &font, int2 size)
+    : font(font), textureSize(size), pixels(size.x * size.y), slots(font.end - font.begin, Slot{-1, 0})
+{
+    // positions are stored with 12 bit in the glyph info
+    assert(size.x <= 4096 && size.y <= 4096);
+}
+
+GlyphAtlas::Glyph GlyphAtlas::get(const GlyphInfo *info) {
+    uint32_t data1 = info->data1;
+    uint32_t data2 = info->data2;
+    int width = (data1 >> 18) & 0x7f;
+    int height = data1 >> 25;
+    int y = (data2 >> 24) & 0x7f;
+
+    // non-printable glyphs such as ' ' need no space in the texture
+    if (height == 0)
+        return {{width, 0}, y, {0, 0}};
+
+    auto &slot = this->slots[info - this->font.begin];
+    if (slot.shelf < 0) {
+        // pack glyph into texture
+        int s = allocate(width + PADDING, height + PADDING);
+        if (s < 0)
+            return {{width, 0}, y, {0, 0}};
+        auto &shelf = this->shelves[s];
+        slot = {s, shelf.x};
+        shelf.glyphs.push_back(int(info - this->font.begin));
+
+        // copy bitmap and clear padding
+        int stride = this->textureSize.x;
+        auto src = this->font.data + (data2 & 0xffffff);
+        auto dst = this->pixels.data() + shelf.y * stride + shelf.x;
+        for (int j = 0; j < height; ++j) {
+            std::memcpy(dst, src, width);
+            std::memset(dst + width, 0, PADDING);
+            src += width;
+            dst += stride;
+        }
+        for (int j = 0; j < PADDING; ++j) {
+            std::memset(dst, 0, width + PADDING);
+            dst += stride;
+        }
+
+        shelf.dirtyBegin = std::min(shelf.dirtyBegin, shelf.x);
+        shelf.x += width + PADDING;
+        shelf.dirtyEnd = std::max(shelf.dirtyEnd, shelf.x);
+    }
+    auto &shelf = this->shelves[slot.shelf];
+    shelf.lastUse = this->frame;
+    return {{width, height}, y, {slot.x, shelf.y}};
+}
+
+GlyphAtlas::Glyph GlyphAtlas::get(int code) {
+    auto begin = this->font.begin + 1;
+    auto info = std::lower_bound(begin, this->font.end, code);
+    if (info == this->font.end || info->code() != code)
+        info = this->font.begin;
+    return get(info);
+}
+
+GlyphInfo GlyphAtlas::getInfo(const GlyphInfo *info) {
+    auto glyph = get(info);
+    return {
+        (info->data1 & 0x3ffff) | (uint32_t(glyph.size.x) << 18) | (uint32_t(glyph.size.y) << 25),
+        uint32_t(glyph.location.x) | (uint32_t(glyph.location.y) << 12) | (uint32_t(glyph.y) << 24)
+    };
+}
+
+std::vector<GlyphAtlas::Rect> GlyphAtlas::takeDirty() {
+    std::vector<Rect> rects;
+    for (auto &shelf : this->shelves) {
+        if (shelf.dirtyBegin < shelf.dirtyEnd) {
+            rects.push_back({{shelf.dirtyBegin, shelf.y}, {shelf.dirtyEnd - shelf.dirtyBegin, shelf.height}});
+            shelf.dirtyBegin = this->textureSize.x;
+            shelf.dirtyEnd = 0;
+        }
+    }
+    return rects;
+}
+
+int GlyphAtlas::allocate(int width, int height) {
+    int textureWidth = this->textureSize.x;
+    if (width > textureWidth || height > this->textureSize.y)
+        return -1;
+
+    // best fit: shelf with lowest height that has enough space left
+    int best = -1;
+    for (int i = 0; i < int(this->shelves.size()); ++i) {
+        auto &shelf = this->shelves[i];
+        if (shelf.height >= height && shelf.x + width <= textureWidth
+            && (best < 0 || shelf.height < this->shelves[best].height))
+        {
+            best = i;
+        }
+    }
+
+    // use best shelf if it does not waste too much space
+    if (best >= 0 && this->shelves[best].height <= height * 2)
+        return best;
+
+    // open a new shelf, height is rounded up to reduce the number of different shelf heights
+    int remaining = this->textureSize.y - this->top;
+    if (height <= remaining) {
+        int shelfHeight = std::min((height + 3) & ~3, remaining);
+        this->shelves.push_back({this->top, shelfHeight, 0, this->frame, textureWidth, 0, {}});
+        this->top += shelfHeight;
+        return int(this->shelves.size()) - 1;
+    }
+
+    // use best shelf even if it wastes space
+    if (best >= 0)
+        return best;
+
+    // find the least recently used run of adjacent shelves that is high enough, the free space below the last shelf
+    // counts too. A single shelf that is high enough is a run of length 1
+    int count = int(this->shelves.size());
+    int runBegin = -1;
+    int runEnd = 0;
+    int runUse = 0;
+    bool runFree = false;
+    for (int i = 0; i < count; ++i) {
+        int h = 0;
+        int use = 0;
+        int j = i;
+        for (; j < count && h < height; ++j) {
+            h += this->shelves[j].height;
+            use = std::max(use, this->shelves[j].lastUse);
+        }
+        bool free = false;
+        if (h < height) {
+            h += this->textureSize.y - this->top;
+            free = true;
+        }
+        if (h < height)
+            break;
+        if (runBegin < 0 || use < runUse || (use == runUse && j - i < runEnd - runBegin)) {
+            runBegin = i;
+            runEnd = j;
+            runUse = use;
+            runFree = free;
+        }
+    }
+    if (runBegin < 0)
+        return -1;
+
+    // evict the run and merge it into its first shelf
+    auto &shelf = this->shelves[runBegin];
+    evict(shelf);
+    for (int i = runBegin + 1; i < runEnd; ++i) {
+        evict(this->shelves[i]);
+        shelf.height += this->shelves[i].height;
+    }
+    if (runFree) {
+        shelf.height += this->textureSize.y - this->top;
+        this->top = this->textureSize.y;
+    }
+    shelf.lastUse = this->frame;
+    this->shelves.erase(this->shelves.begin() + runBegin + 1, this->shelves.begin() + runEnd);
+
+    // split off the space that is not needed as a new empty shelf
+    int shelfHeight = std::min((height + 3) & ~3, shelf.height);
+    int rest = shelf.height - shelfHeight;
+    if (rest > 0) {
+        shelf.height = shelfHeight;
+        Shelf restShelf = {shelf.y + shelfHeight, rest, 0, runUse, textureWidth, 0, {}};
+        this->shelves.insert(this->shelves.begin() + runBegin + 1, std::move(restShelf));
+    }
+
+    // update shelf index of glyphs in the following shelves
+    for (int i = runBegin + 1; i < int(this->shelves.size()); ++i) {
+        for (int index : this->shelves[i].glyphs)
+            this->slots[index].shelf = i;
+    }
+    return runBegin;
+}
+
+void GlyphAtlas::evict(Shelf &shelf) {
+    for (int index : shelf.glyphs)
+        this->slots[index].shelf = -1;
+    shelf.glyphs.clear();
+    shelf.x = 0;
+    ++this->evictions;
+}
+
+} // namespace coco
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Font.hpp"
+#include <vector>
+
+
+namespace coco {
+
+/// @brief Dynamic glyph atlas that packs the glyphs of a linear 8 bit per pixel font on demand into a fixed size
+/// texture. Glyphs are packed into shelves (rows of glyphs). When the texture is full, the least recently used
+/// shelf is evicted and reused. If no shelf is high enough, the least recently used run of adjacent shelves is
+/// evicted and merged into one shelf. The changed parts of the texture are reported as dirty rectangles for upload.
+/// The returned glyphs use the same location format as TextureFont (12 bit x/y positions).
+/// Note that eviction can invalidate glyphs that were returned before, therefore draw calls that use the texture
+/// should be flushed when dirty rectangles appear.
+class GlyphAtlas {
+public:
+    using Glyph = TextureFont::Glyph;
+
+    struct Rect {
+        int2 position;
+        int2 size;
+    };
+
+    /// @brief Constructor
+    /// @param font Source font with 8 bit per pixel glyph bitmaps
+    /// @param size Size of the texture, at most 4096x4096
+    GlyphAtlas(const LinearFont &font, int2 size);
+
+    /// @brief Get glyph, packs it into the texture if necessary
+    /// @param info Glyph info of the source font
+    /// @return Glyph with location on the texture, size.y is 0 if the glyph does not fit into the texture
+    Glyph get(const GlyphInfo *info);
+
+    /// @brief Get glyph for a code, the placeholder is used if the code is not in the font
+    /// @param code Code point
+    /// @return Glyph with location on the texture
+    Glyph get(int code);
+
+    /// @brief Get glyph info with the glyph location encoded like in a TextureFont
+    /// @param info Glyph info of the source font
+    /// @return Glyph info for the texture
+    GlyphInfo getInfo(const GlyphInfo *info);
+
+    /// @brief Start a new frame, glyphs that are used in the current frame are only evicted if no other shelf fits
+    ///
+    void nextFrame() {++this->frame;}
+
+    /// @brief Get texture data (8 bit per pixel, row by row)
+    /// @return Texture data
+    const uint8_t *texture() const {return this->pixels.data();}
+
+    /// @brief Get size of texture
+    /// @return Texture size
+    int2 size() const {return this->textureSize;}
+
+    /// @brief Get sub-rectangles of the texture that changed since the last call and need to be uploaded
+    /// @return List of dirty rectangles
+    std::vector<Rect> takeDirty();
+
+    /// @brief Get number of evicted shelves for statistics
+    /// @return Number of evictions
+    int evictionCount() const {return this->evictions;}
+
+
+    struct GlyphRange {
+        GlyphAtlas &atlas;
+        LinearFont::GlyphRange range;
+
+        struct Iterator {
+            GlyphAtlas &atlas;
+            LinearFont::GlyphRange::Iterator it;
+
+            Iterator &operator ++() {
+                ++this->it;
+                return *this;
+            }
+
+            bool operator ==(const Iterator &other) const {
+                return this->it == other.it;
+            }
+
+            Glyph operator *() {
+                return this->atlas.get(this->it.info);
+            }
+        };
+
+        Iterator begin() {return {this->atlas, this->range.begin()};}
+        Iterator end() {return {this->atlas, this->range.end()};}
+    };
+
+    /// @brief Get glyph range for text that can be used to iterate over glyphs in range-based for loop, see
+    /// Font::glyphRange()
+    /// @param text Text to get glyphs for
+    /// @return GlyphRange object that can be used in range-based for loop
+    GlyphRange glyphRange(String text) {return {*this, this->font.glyphRange(text)};}
+
+protected:
+    struct Shelf {
+        int y;
+        int height;
+
+        // fill position
+        int x;
+
+        // last frame in which a glyph of this shelf was used
+        int lastUse;
+
+        // dirty range in x direction
+        int dirtyBegin;
+        int dirtyEnd;
+
+        // glyph indices that are packed into this shelf
+        std::vector<int> glyphs;
+    };
+
+    struct Slot {
+        // shelf index or -1 if the glyph is not in the texture
+        int shelf;
+        int x;
+    };
+
+    // find or create a shelf for a glyph of given size including padding
+    int allocate(int width, int height);
+
+    // evict all glyphs of a shelf
+    void evict(Shelf &shelf);
+
+    // copy of the source font (a font is a small struct), therefore a font returned by value can be passed
+    LinearFont font;
+    int2 textureSize;
+    std::vector<uint8_t> pixels;
+    std::vector<Shelf> shelves;
+
+    // y-position for the next shelf
+    int top = 0;
+
+    // slot for each glyph of the font
+    std::vector<Slot> slots;
+
+    int frame = 0;
+    int evictions = 0;
+};
+
+} // namespace coco
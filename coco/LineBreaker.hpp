@@ -0,0 +1,232 @@
+#pragma once
+
+#include "Font.hpp"
+#include <coco/String.hpp>
+#include <algorithm>
+
+
+namespace coco {
+
+/// @brief Line breaker that wraps a paragraph into lines of a maximum width in a single pass over the glyphs.
+/// Breaks are allowed after spaces (which hang at the end of the line), after hyphens, before and after CJK
+/// characters and are forced by '\n'. Words that are wider than a line are broken between glyphs.
+/// The line storage is provided by LineBreakerBuffer.
+/// @tparam F Font type, e.g. LinearFont
+template <typename F>
+class LineBreaker {
+public:
+    struct Line {
+        // byte offset of first glyph of the line
+        int begin;
+
+        // byte offset after the last glyph of the line, excluding trailing spaces
+        int end;
+
+        // width of the line, same as font.calcWidth(text.substring(begin, end))
+        int width;
+    };
+
+
+    LineBreaker(const LineBreaker &) = delete;
+    LineBreaker &operator =(const LineBreaker &) = delete;
+
+    /// @brief Set maximum line width. Call layout() afterwards
+    /// @param maxWidth Maximum line width
+    void setMaxWidth(int maxWidth) {this->maxWidth = maxWidth;}
+
+    /// @brief Break the whole text into lines
+    /// @param text Text
+    /// @return true if successful, false if the capacity was exceeded and the lines are truncated
+    bool layout(String text) {
+        int pos = 0;
+        int w = 0;
+        while (true) {
+            if (w >= this->capacity)
+                return finish(w, false);
+            auto b = breakLine(text, pos);
+            this->lines[w++] = b.line;
+            if (b.next < 0)
+                return finish(w, true);
+            pos = b.next;
+        }
+    }
+
+    /// @brief Update the lines after an edit of the text. Only the lines from the line before the edit are broken
+    /// again until the line starts resynchronize with the old lines
+    /// @param text New text
+    /// @param editBegin Byte offset of the edit
+    /// @param removed Number of bytes that were removed at editBegin
+    /// @param inserted Number of bytes that were inserted at editBegin
+    /// @return true if successful, false if the capacity was exceeded and the lines are truncated
+    bool reflow(String text, int editBegin, int removed, int inserted) {
+        if (this->count == 0)
+            return layout(text);
+        int delta = inserted - removed;
+
+        // find the line that contains the edit (an edit at the begin of a line belongs to the previous line) and start
+        // at the line before. A line looks ahead until the glyph that overflows, which is at most at the begin of the
+        // line after next, therefore lines further before are not affected
+        auto it = std::lower_bound(this->lines + 1, this->lines + this->count, editBegin,
+            [](const Line &line, int pos) {return line.begin < pos;});
+        int start = std::max(int(it - this->lines) - 2, 0);
+
+        // move old lines after the start line to the end of the buffer
+        int t = this->capacity - (this->count - start - 1);
+        std::copy_backward(this->lines + start + 1, this->lines + this->count, this->lines + this->capacity);
+
+        int pos = this->lines[start].begin;
+        int w = start;
+        while (true) {
+            if (w >= t)
+                return finish(w, false);
+            auto b = breakLine(text, pos);
+            this->lines[w++] = b.line;
+            if (b.next < 0)
+                return finish(w, true);
+            pos = b.next;
+
+            // skip old lines that start inside the edit or before the current position
+            while (t < this->capacity && (this->lines[t].begin < editBegin + removed || this->lines[t].begin + delta < pos))
+                ++t;
+
+            // check if the line starts resynchronize, then the remaining old lines only get shifted
+            if (t < this->capacity && this->lines[t].begin + delta == pos) {
+                for (; t < this->capacity; ++t) {
+                    auto line = this->lines[t];
+                    this->lines[w++] = {line.begin + delta, line.end + delta, line.width};
+                }
+                return finish(w, this->complete);
+            }
+        }
+    }
+
+    /// @brief Check if the last layout() or reflow() fitted into the capacity
+    /// @return true if complete
+    bool isComplete() const {return this->complete;}
+
+    /// @brief Get the font that is used to measure the lines
+    /// @return Font
+    const F &getFont() const {return this->font;}
+
+    int size() const {return this->count;}
+    const Line &operator [](int index) const {return this->lines[index];}
+    const Line *begin() const {return this->lines;}
+    const Line *end() const {return this->lines + this->count;}
+
+    /// @brief Check if a line can be broken before the given code (CJK inter-character break)
+    /// @param code Code point
+    /// @return true if the code is an ideographic/wide character
+    static bool isIdeographic(int code) {
+        return (code >= 0x2E80 && code <= 0x9FFF) // CJK radicals, Kana, CJK unified ideographs
+            || (code >= 0xAC00 && code <= 0xD7AF) // Hangul syllables
+            || (code >= 0xF900 && code <= 0xFAFF) // CJK compatibility ideographs
+            || (code >= 0xFF00 && code <= 0xFFEF) // full width forms
+            || (code >= 0x20000 && code <= 0x3FFFF); // supplementary ideographic planes
+    }
+
+protected:
+    LineBreaker(const F &font, int maxWidth, Line *lines, int capacity)
+        : font(font), maxWidth(maxWidth), lines(lines), capacity(capacity) {}
+
+    struct Break {
+        Line line;
+
+        // begin of next line or -1 if the end of the text was reached
+        int next;
+    };
+
+    // break one line starting at byte offset begin
+    Break breakLine(String text, int begin) const {
+        auto data = (const uint8_t*)text.data();
+        int size = text.size();
+
+        // running width
+        int x = 0;
+
+        // end and width of line without trailing spaces
+        int contentEnd = begin;
+        int contentWidth = 0;
+
+        // last break opportunity
+        Break candidate = {{begin, begin, 0}, -1};
+
+        int p = begin;
+        auto range = this->font.glyphRange(text.substring(begin));
+        for (auto it = range.begin(); it != range.end(); ++it) {
+            auto glyph = *it;
+            int q = size - it.remaining();
+            int g = glyph.size.x + this->font.gapWidth;
+
+            // first code of glyph
+            auto d = data + p;
+            int code = decodeUtf8(d, data + size);
+
+            if (code == '\n')
+                return {{begin, contentEnd, contentWidth}, q};
+
+            if (code == ' ') {
+                // spaces hang at the end of the line, leading spaces belong to the first word (a break there would
+                // produce an empty line)
+                if (contentEnd > begin)
+                    candidate = {{begin, contentEnd, contentWidth}, q};
+                x += g;
+                p = q;
+                continue;
+            }
+
+            bool ideographic = isIdeographic(code);
+            if (ideographic && contentEnd > begin)
+                candidate = {{begin, contentEnd, contentWidth}, p};
+
+            if (x + g > this->maxWidth && contentEnd > begin) {
+                // line overflows: break at last opportunity or before the current glyph
+                if (candidate.next >= 0)
+                    return candidate;
+                return {{begin, contentEnd, contentWidth}, p};
+            }
+
+            x += g;
+            contentEnd = q;
+            contentWidth = x;
+
+            if (ideographic || code == '-')
+                candidate = {{begin, contentEnd, contentWidth}, q};
+            p = q;
+        }
+        return {{begin, contentEnd, contentWidth}, -1};
+    }
+
+    bool finish(int count, bool complete) {
+        this->count = count;
+        this->complete = complete;
+        return complete;
+    }
+
+    // copy of the font (a font is a small struct), therefore a font returned by value can be passed to the constructor
+    F font;
+    int maxWidth;
+
+    // line storage
+    Line *lines;
+    int capacity;
+
+    // number of lines
+    int count = 0;
+    bool complete = true;
+};
+
+/// @brief Line breaker with storage for N lines
+/// @tparam F Font type, e.g. LinearFont
+/// @tparam N Maximum number of lines
+template <typename F, int N>
+class LineBreakerBuffer : public LineBreaker<F> {
+public:
+    using Line = typename LineBreaker<F>::Line;
+
+    LineBreakerBuffer(const F &font, int maxWidth) : LineBreaker<F>(font, maxWidth, buffer, N) {}
+
+protected:
+    Line buffer[N];
+};
+
+} // namespace coco
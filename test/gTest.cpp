@@ -1,7 +1,15 @@
 #include <gtest/gtest.h>
+#include <coco/BatchMeasure.hpp>
 //#include "font/tahoma16pt8bpp.hpp"
 #include <coco/Font.hpp>
+#include <coco/FontCoverage.hpp>
+#include <coco/FontOptimizer.hpp>
+#include <coco/GlyphAtlas.hpp>
+#include <coco/LineBreaker.hpp>
+#include <map>
+#include <random>
 #include <ranges>
+#include <string>
 
 using namespace coco;
 
@@ -62,6 +70,11 @@ TEST(cocoTest, drawText) {
 // test code for Font.hpp
 // ----------------------
 
+// create glyph info from its fields
+constexpr GlyphInfo glyphInfo(int code, int width, int height, int location, int y) {
+    return {uint32_t(code | (width << 18) | (height << 25)), uint32_t(location | (y << 24))};
+}
+
 // list of glyph infos for testing (without bitmap data)
 static const GlyphInfo glyphs[] = {
     // {code, clocation}
@@ -101,6 +114,25 @@ TEST(cocoTest, GlyphIterator) {
     }
 }
 
+TEST(cocoTest, GlyphIteratorConcept) {
+    using Iterator = LinearFont::GlyphRange::Iterator;
+    static_assert(std::is_trivially_copyable_v<Iterator>);
+    static_assert(std::is_trivially_copyable_v<LinearFont::GlyphRange>);
+    static_assert(sizeof(Iterator) == 5 * sizeof(void *)); // font, current, next, end, info
+    static_assert(std::forward_iterator<Iterator>);
+    static_assert(std::ranges::forward_range<LinearFont::GlyphRange>);
+    static_assert(std::forward_iterator<MonospaceFont<5, 7, 35>::GlyphRange::Iterator>);
+
+    // use with ranges algorithms
+    auto range = font.glyphRange(text);
+    EXPECT_EQ(std::ranges::distance(range), 7);
+    EXPECT_EQ(std::ranges::count_if(range, [](const auto &glyph) {return glyph.location == 0;}), 2);
+
+    // empty text
+    auto empty = font.glyphRange("");
+    EXPECT_TRUE(empty.begin() == empty.end());
+}
+
 TEST(cocoTest, calcWidth) {
     int w = font.calcWidth(text);
 
@@ -124,6 +156,680 @@ TEST(cocoTest, prevCode) {
     EXPECT_EQ(font.prevCode(0xfffff), 0x1F60A);
 }
 
+TEST(cocoTest, FontCoverage) {
+    // font covers 3 pages: 0, 11 (0x2EB7) and 125 (0x1F60A)
+    FontCoverageBuffer<3> coverage(font);
+    EXPECT_EQ(coverage.pageCount(), 3);
+
+    // placeholder is not included
+    EXPECT_FALSE(coverage.covers(0));
+    EXPECT_TRUE(coverage.covers(32));
+    EXPECT_TRUE(coverage.covers(65));
+    EXPECT_FALSE(coverage.covers(67));
+    EXPECT_TRUE(coverage.covers(0x2EB7));
+    EXPECT_TRUE(coverage.covers(0x1F60A));
+    EXPECT_FALSE(coverage.covers(0x1F60B));
+    EXPECT_FALSE(coverage.covers(-1));
+    EXPECT_FALSE(coverage.covers(0x40000));
+
+    // coverage of strings
+    EXPECT_TRUE(coverage.coversAll(""));
+    EXPECT_TRUE(coverage.coversAll(" ABÖ⺷😊"));
+    EXPECT_TRUE(coverage.coversAll("ABBA ABBA ABBA ABBA Ö"));
+    EXPECT_FALSE(coverage.coversAll(text));
+    EXPECT_FALSE(coverage.coversAll("ABBA ABBA ABBA ABBX"));
+    EXPECT_FALSE(coverage.coversAll("AÄ"));
+    EXPECT_FALSE(coverage.coversAll(String("A\xC3", 2)));
+
+    // enumeration must give the same result as the font
+    const int codes[] = {-1, 0, 1, 31, 32, 33, 64, 65, 66, 67, 0xD6, 0x400, 0x2EB7, 0x2EB8, 0x1F609, 0x1F60A, 0x3ffff, 0xfffff};
+    for (int code : codes) {
+        EXPECT_EQ(coverage.next(code), font.nextCode(code)) << code;
+        if (code >= 0) {
+            EXPECT_EQ(coverage.prev(code), font.prevCode(code)) << code;
+        }
+    }
+
+    // not enough pages
+    FontCoverageBuffer<2> small;
+    EXPECT_FALSE(small.build(font));
+}
+
+// monospace font with codes 32 to 126, 5x7 pixels at 8 bit per pixel
+static const MonospaceFont<5, 7, 5 * 7> monospaceFont = {
+    1, // gapWidth
+    nullptr, // bitmap data
+    32, // first code
+    95 // count
+};
+
+TEST(cocoTest, MonospaceFont) {
+    // 'X', ' ', 'A' are in the font, 'Ö', '⺷', '😊' map to the placeholder
+    const int expected[] = {(1 + 'X' - 32) * 35, 35, (1 + 'A' - 32) * 35, 0, 0, 0};
+    int i = 0;
+    for (auto glyph : monospaceFont.glyphRange("X AÖ⺷😊")) {
+        EXPECT_EQ(glyph.size.x, 5);
+        EXPECT_EQ(glyph.size.y, 7);
+        EXPECT_EQ(glyph.location, expected[i]);
+        ++i;
+    }
+    EXPECT_EQ(i, 6);
+
+    EXPECT_EQ(monospaceFont.calcWidth(text), 7 * (5 + 1));
+    EXPECT_EQ(monospaceFont.calcWidth(""), 0);
+
+    EXPECT_EQ(monospaceFont.nextCode(0), 32);
+    EXPECT_EQ(monospaceFont.nextCode(32), 33);
+    EXPECT_EQ(monospaceFont.nextCode(126), 32);
+    EXPECT_EQ(monospaceFont.prevCode(0), 126);
+    EXPECT_EQ(monospaceFont.prevCode(32), 126);
+    EXPECT_EQ(monospaceFont.prevCode(33), 32);
+    EXPECT_EQ(monospaceFont.prevCode(0xfffff), 126);
+
+    // font without glyphs
+    const MonospaceFont<5, 7, 5 * 7> emptyFont = {1, nullptr, 32, 0};
+    EXPECT_EQ(emptyFont.nextCode(32), -1);
+    EXPECT_EQ(emptyFont.prevCode(32), -1);
+}
+
+TEST(cocoTest, MonospaceFontMalformed) {
+    // each invalid byte is one placeholder glyph, calcWidth() must be consistent with the glyph range
+    String texts[] = {"\x80", "\xE2\x82" "a", "\xC3" "a", "a\x80\x80", "\xF0\x9F\x98", "\xC3\xA4\xFF", "Ö\xE2",
+        "\xC1\x81"};
+    const int glyphCounts[] = {1, 3, 2, 3, 3, 2, 2, 2};
+    for (int i = 0; i < int(std::size(texts)); ++i) {
+        int count = 0;
+        for (auto glyph : monospaceFont.glyphRange(texts[i])) {
+            (void)glyph;
+            ++count;
+        }
+        EXPECT_EQ(count, glyphCounts[i]) << i;
+        EXPECT_EQ(monospaceFont.calcWidth(texts[i]), count * (5 + monospaceFont.gapWidth)) << i;
+
+        // linear font splits the text in the same way ('a' is not in the font, therefore each glyph is the
+        // placeholder except 'Ö')
+        int linearCount = 0;
+        int placeholderCount = 0;
+        for (auto glyph : font.glyphRange(texts[i])) {
+            ++linearCount;
+            if (glyph.location == 0)
+                ++placeholderCount;
+        }
+        EXPECT_EQ(linearCount, count) << i;
+        EXPECT_EQ(placeholderCount, i == 6 ? count - 1 : count) << i;
+        EXPECT_EQ(font.calcWidth(texts[i]), count * font.gapWidth) << i;
+    }
+}
+
+// get lines as strings
+template <typename F>
+std::vector<std::string> getLines(const LineBreaker<F> &breaker, String text) {
+    std::vector<std::string> lines;
+    for (auto &line : breaker) {
+        auto s = text.substring(line.begin, line.end);
+        EXPECT_EQ(line.width, breaker.getFont().calcWidth(s));
+        lines.emplace_back(s.data(), s.size());
+    }
+    return lines;
+}
+
+TEST(cocoTest, LineBreaker) {
+    // 10 glyphs per line
+    LineBreakerBuffer<MonospaceFont<5, 7, 5 * 7>, 16> breaker(monospaceFont, 60);
+
+    EXPECT_TRUE(breaker.layout(""));
+    EXPECT_EQ(getLines(breaker, ""), std::vector<std::string>({""}));
+
+    String text1 = "hello world foo";
+    EXPECT_TRUE(breaker.layout(text1));
+    EXPECT_EQ(getLines(breaker, text1), std::vector<std::string>({"hello", "world foo"}));
+
+    String text2 = "abcdefghijklmnop";
+    EXPECT_TRUE(breaker.layout(text2));
+    EXPECT_EQ(getLines(breaker, text2), std::vector<std::string>({"abcdefghij", "klmnop"}));
+
+    String text3 = "well-known-fact";
+    EXPECT_TRUE(breaker.layout(text3));
+    EXPECT_EQ(getLines(breaker, text3), std::vector<std::string>({"well-", "known-fact"}));
+
+    String text4 = "a  \nb\n";
+    EXPECT_TRUE(breaker.layout(text4));
+    EXPECT_EQ(getLines(breaker, text4), std::vector<std::string>({"a", "b", ""}));
+
+    String text5 = "ab 日本語日本語日本語";
+    EXPECT_TRUE(breaker.layout(text5));
+    EXPECT_EQ(getLines(breaker, text5), std::vector<std::string>({"ab 日本語日本語日", "本語"}));
+
+    // capacity exceeded
+    LineBreakerBuffer<MonospaceFont<5, 7, 5 * 7>, 2> small(monospaceFont, 60);
+    EXPECT_FALSE(small.layout("a\nb\nc"));
+    EXPECT_EQ(small.size(), 2);
+}
+
+TEST(cocoTest, LineBreakerLeadingSpaces) {
+    LineBreakerBuffer<MonospaceFont<5, 7, 5 * 7>, 16> breaker(monospaceFont, 60);
+
+    // leading spaces stay on the line of the first word
+    String text1 = " abcdefghijklm";
+    EXPECT_TRUE(breaker.layout(text1));
+    EXPECT_EQ(getLines(breaker, text1), std::vector<std::string>({" abcdefghi", "jklm"}));
+
+    String text2 = "ab\n  cdefghijklm";
+    EXPECT_TRUE(breaker.layout(text2));
+    EXPECT_EQ(getLines(breaker, text2), std::vector<std::string>({"ab", "  cdefghij", "klm"}));
+
+    String text3 = "   ";
+    EXPECT_TRUE(breaker.layout(text3));
+    EXPECT_EQ(getLines(breaker, text3), std::vector<std::string>({""}));
+}
+
+// proportional font with different glyph widths (without bitmap data)
+static const std::vector<GlyphInfo> proportionalGlyphs = [] {
+    std::vector<GlyphInfo> glyphs;
+    glyphs.push_back(glyphInfo(0, 4, 7, 0, 0)); // placeholder
+    glyphs.push_back(glyphInfo(' ', 3, 0, 0, 0));
+    glyphs.push_back(glyphInfo('-', 4, 1, 0, 3));
+    for (int c = 'a'; c <= 'z'; ++c)
+        glyphs.push_back(glyphInfo(c, c * 7 % 6 + 2, 7, 0, 0));
+    glyphs.push_back(glyphInfo(0x65E5, 11, 10, 0, 0)); // 日
+    return glyphs;
+}();
+
+static const LinearFont proportionalFont = {
+    1, // gapWidth
+    10, // height
+    nullptr, // bitmap data
+    0, // bitmap data size
+    proportionalGlyphs.data(),
+    proportionalGlyphs.data() + proportionalGlyphs.size()
+};
+
+TEST(cocoTest, LineBreakerProportional) {
+    LineBreakerBuffer<LinearFont, 16> breaker(proportionalFont, 37);
+
+    String text1 = " xbcloxngerword";
+    EXPECT_TRUE(breaker.layout(text1));
+    EXPECT_EQ(getLines(breaker, text1), std::vector<std::string>({" xbcloxn", "gerwor", "d"}));
+
+    String text2 = "ab cd-ef 日日日日";
+    EXPECT_TRUE(breaker.layout(text2));
+    EXPECT_EQ(getLines(breaker, text2), std::vector<std::string>({"ab cd-", "ef 日", "日日日"}));
+
+    // the breaker keeps a copy of the font, e.g. a temporary font returned by OptimizedFont::font()
+    LineBreakerBuffer<LinearFont, 16> copy(LinearFont(proportionalFont), 37);
+    EXPECT_TRUE(copy.layout(text1));
+    EXPECT_EQ(getLines(copy, text1), std::vector<std::string>({" xbcloxn", "gerwor", "d"}));
+}
+
+// check that reflow() after random edits gives the same lines as layout()
+template <typename F>
+void testReflow(const F &font, int maxWidth) {
+    LineBreakerBuffer<F, 1024> breaker(font, maxWidth);
+    LineBreakerBuffer<F, 1024> reference(font, maxWidth);
+
+    const char *pieces[] = {"a", "bc", " ", "  ", "-", "\n", "日", "word ", "longerword", " x"};
+    std::mt19937 random(maxWidth);
+    std::string text;
+    for (int i = 0; i < 200; ++i)
+        text += pieces[random() % std::size(pieces)];
+    breaker.layout(String(text.data(), int(text.size())));
+
+    for (int i = 0; i < 2000; ++i) {
+        // random edit at a character boundary
+        int editBegin = random() % (text.size() + 1);
+        while (editBegin > 0 && (text[editBegin] & 0xC0) == 0x80)
+            --editBegin;
+        int removed = 0;
+        if (random() % 2 || text.size() > 300) {
+            int e = std::min(editBegin + int(random() % 8), int(text.size()));
+            while (e < int(text.size()) && (text[e] & 0xC0) == 0x80)
+                ++e;
+            removed = e - editBegin;
+        }
+        std::string insert = random() % 3 ? pieces[random() % std::size(pieces)] : "";
+        text.replace(editBegin, removed, insert);
+
+        String t(text.data(), int(text.size()));
+        EXPECT_TRUE(breaker.reflow(t, editBegin, removed, insert.size()));
+        EXPECT_TRUE(reference.layout(t));
+        ASSERT_EQ(getLines(breaker, t), getLines(reference, t)) << "maxWidth " << maxWidth << " edit " << i;
+    }
+}
+
+TEST(cocoTest, LineBreakerReflow) {
+    for (int maxWidth : {5, 37, 60})
+        testReflow(monospaceFont, maxWidth);
+}
+
+TEST(cocoTest, LineBreakerReflowProportional) {
+    for (int maxWidth : {5, 17, 37, 60, 100})
+        testReflow(proportionalFont, maxWidth);
+}
+
+// 8 bit per pixel bitmap data for testing font optimization
+static const uint8_t bitmapData[] = {
+    // placeholder (2x2)
+    9, 9,
+    9, 9,
+    // 'A' (2x4) with blank rows
+    0, 0,
+    1, 2,
+    3, 4,
+    0, 0,
+    // 'B' (2x2) same as trimmed 'A'
+    1, 2,
+    3, 4,
+    // 'C' (2x2) blank
+    0, 0,
+    0, 0,
+};
+
+static const GlyphInfo bitmapGlyphs[] = {
+    glyphInfo(0, 2, 2, 0, 0),
+    glyphInfo(32, 2, 0, 0, 0),
+    glyphInfo(65, 2, 4, 4, 0),
+    glyphInfo(66, 2, 2, 12, 1),
+    glyphInfo(67, 2, 2, 16, 1),
+};
+
+static const LinearFont bitmapFont = {
+    1, // gapWidth
+    4, // height
+    bitmapData,
+    sizeof(bitmapData),
+    std::begin(bitmapGlyphs),
+    std::end(bitmapGlyphs)
+};
+
+// render text into rows of font height
+std::vector<int> render(const LinearFont &font, String text) {
+    std::vector<int> pixels;
+    for (auto glyph : font.glyphRange(text)) {
+        std::vector<int> bitmap(glyph.size.x * font.height);
+        for (int j = 0; j < glyph.size.y; ++j) {
+            for (int i = 0; i < glyph.size.x; ++i)
+                bitmap[(glyph.y + j) * glyph.size.x + i] = font.data[glyph.location + j * glyph.size.x + i];
+        }
+        pixels.insert(pixels.end(), bitmap.begin(), bitmap.end());
+    }
+    return pixels;
+}
+
+TEST(cocoTest, OptimizedFont) {
+    OptimizedFont optimized(bitmapFont, 8);
+    auto font = optimized.font();
+    auto &report = optimized.report();
+
+    EXPECT_EQ(report.glyphCount, 5);
+    EXPECT_EQ(report.trimmedGlyphCount, 2);
+    EXPECT_EQ(report.trimmedRows, 4);
+    EXPECT_EQ(report.sharedGlyphCount, 1);
+    EXPECT_EQ(report.dataSizeBefore, 20);
+    EXPECT_EQ(report.dataSizeAfter, 8);
+    EXPECT_EQ(report.glyphBytesBefore, 20);
+    EXPECT_EQ(report.glyphBytesAfter, 12);
+
+    // 'A' and 'B' share the bitmap
+    EXPECT_EQ(font.begin[2].data2, font.begin[3].data2);
+
+    // rendering and layout are unchanged
+    EXPECT_EQ(render(font, "X ABC"), render(bitmapFont, "X ABC"));
+    EXPECT_EQ(font.calcWidth("X ABC"), bitmapFont.calcWidth("X ABC"));
+}
+
+// 1 bit per pixel bitmap data, rows are padded to full bytes
+static const uint8_t bitmapData1[] = {
+    // placeholder (10x2)
+    0xff, 0xc0,
+    0xff, 0xc0,
+    // 'A' (10x4) with blank rows
+    0x00, 0x00,
+    0x80, 0x40,
+    0x00, 0x00,
+    0x00, 0x00,
+    // 'B' (10x2) same as trimmed 'A'
+    0x80, 0x40,
+    // 'C' (10x3) with y = 126, only one of the two blank rows fits into y
+    0x00, 0x00,
+    0x00, 0x00,
+    0x12, 0x00,
+};
+
+static const GlyphInfo bitmapGlyphs1[] = {
+    glyphInfo(0, 10, 2, 0, 0),
+    glyphInfo(65, 10, 4, 4, 2),
+    glyphInfo(66, 10, 1, 12, 3),
+    glyphInfo(67, 10, 3, 14, 126),
+};
+
+static const LinearFont bitmapFont1 = {
+    1, // gapWidth
+    8, // height
+    bitmapData1,
+    sizeof(bitmapData1),
+    std::begin(bitmapGlyphs1),
+    std::end(bitmapGlyphs1)
+};
+
+TEST(cocoTest, OptimizedFont1Bit) {
+    OptimizedFont optimized(bitmapFont1, 1);
+    auto font = optimized.font();
+    auto &report = optimized.report();
+
+    EXPECT_EQ(report.trimmedGlyphCount, 2);
+    EXPECT_EQ(report.trimmedRows, 3 + 1);
+    EXPECT_EQ(report.sharedGlyphCount, 1);
+    EXPECT_EQ(report.dataSizeBefore, 20);
+    EXPECT_EQ(report.dataSizeAfter, 4 + 2 + 4);
+
+    // 'A': one row at y = 3 shared with 'B'
+    EXPECT_EQ(font.begin[1].data1, glyphInfo(65, 10, 1, 0, 0).data1);
+    EXPECT_EQ(font.begin[1].data2, font.begin[2].data2);
+    EXPECT_EQ((font.begin[1].data2 >> 24) & 0x7f, 3);
+    auto a = font.data + (font.begin[1].data2 & 0xffffff);
+    EXPECT_EQ(a[0], 0x80);
+    EXPECT_EQ(a[1], 0x40);
+
+    // 'C': y is limited to 127 and the extended flag is not set
+    auto &c = font.begin[3];
+    EXPECT_EQ(c.data1 >> 25, 2);
+    EXPECT_EQ((c.data2 >> 24) & 0x7f, 127);
+    EXPECT_FALSE(c.extended());
+    auto d = font.data + (c.data2 & 0xffffff);
+    EXPECT_EQ(d[2], 0x12);
+}
+
+// 4 bit per pixel bitmap data, rows of width 3 are padded to 2 bytes
+static const uint8_t bitmapData4[] = {
+    // placeholder (3x2)
+    0xff, 0xf0,
+    0xff, 0xf0,
+    // 'A' (3x3) with blank rows at the top and bottom
+    0x00, 0x00,
+    0x12, 0x30,
+    0x00, 0x00,
+    // 'B' (3x1) same as trimmed 'A'
+    0x12, 0x30,
+};
+
+static const GlyphInfo bitmapGlyphs4[] = {
+    glyphInfo(0, 3, 2, 0, 0),
+    glyphInfo(65, 3, 3, 4, 1),
+    glyphInfo(66, 3, 1, 10, 2),
+};
+
+static const LinearFont bitmapFont4 = {
+    1, // gapWidth
+    4, // height
+    bitmapData4,
+    sizeof(bitmapData4),
+    std::begin(bitmapGlyphs4),
+    std::end(bitmapGlyphs4)
+};
+
+TEST(cocoTest, OptimizedFont4Bit) {
+    OptimizedFont optimized(bitmapFont4, 4);
+    auto font = optimized.font();
+    auto &report = optimized.report();
+
+    EXPECT_EQ(report.trimmedGlyphCount, 1);
+    EXPECT_EQ(report.trimmedRows, 2);
+    EXPECT_EQ(report.sharedGlyphCount, 1);
+    EXPECT_EQ(report.dataSizeAfter, 4 + 2);
+    EXPECT_EQ(report.glyphBytesBefore, 4 + 6 + 2);
+    EXPECT_EQ(report.glyphBytesAfter, 4 + 2 + 2);
+
+    // 'A': one row at y = 2 shared with 'B'
+    EXPECT_EQ(font.begin[1].data1, glyphInfo(65, 3, 1, 0, 0).data1);
+    EXPECT_EQ(font.begin[1].data2, font.begin[2].data2);
+    EXPECT_EQ((font.begin[1].data2 >> 24) & 0x7f, 2);
+    auto a = font.data + (font.begin[1].data2 & 0xffffff);
+    EXPECT_EQ(a[0], 0x12);
+    EXPECT_EQ(a[1], 0x30);
+}
+
+// check if a glyph on the atlas texture matches the glyph of the source font
+bool matches(const GlyphAtlas &atlas, const GlyphAtlas::Glyph &glyph, const GlyphInfo &info,
+    const LinearFont &font = bitmapFont)
+{
+    auto src = font.data + (info.data2 & 0xffffff);
+    for (int j = 0; j < glyph.size.y; ++j) {
+        for (int i = 0; i < glyph.size.x; ++i) {
+            int x = glyph.location.x + i;
+            int y = glyph.location.y + j;
+            if (atlas.texture()[y * atlas.size().x + x] != src[j * glyph.size.x + i])
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST(cocoTest, GlyphAtlas) {
+    // space for two glyphs of width 2 plus padding
+    GlyphAtlas atlas(bitmapFont, {6, 6});
+
+    auto a = atlas.get('A');
+    EXPECT_EQ(a.size.x, 2);
+    EXPECT_EQ(a.size.y, 4);
+    EXPECT_EQ(a.location.x, 0);
+    EXPECT_EQ(a.location.y, 0);
+    EXPECT_TRUE(matches(atlas, a, bitmapGlyphs[2]));
+
+    auto b = atlas.get('B');
+    EXPECT_EQ(b.location.x, 3);
+    EXPECT_EQ(b.location.y, 0);
+    EXPECT_TRUE(matches(atlas, b, bitmapGlyphs[3]));
+
+    // second get does not pack again
+    EXPECT_EQ(atlas.get('A').location.x, 0);
+
+    auto dirty = atlas.takeDirty();
+    ASSERT_EQ(dirty.size(), 1);
+    EXPECT_EQ(dirty[0].position.x, 0);
+    EXPECT_EQ(dirty[0].size.x, 6);
+    EXPECT_EQ(dirty[0].size.y, 6);
+    EXPECT_TRUE(atlas.takeDirty().empty());
+
+    // space has no bitmap
+    EXPECT_EQ(atlas.get(' ').size.y, 0);
+
+    // texture is full: unknown character 'X' (placeholder) evicts the shelf
+    atlas.nextFrame();
+    auto x = atlas.get('X');
+    EXPECT_EQ(atlas.evictionCount(), 1);
+    EXPECT_TRUE(matches(atlas, x, bitmapGlyphs[0]));
+
+    // glyph info uses the TextureFont location format
+    auto info = atlas.getInfo(&bitmapGlyphs[2]);
+    auto location = TextureFontTraits::getLocation(info.data2);
+    EXPECT_EQ(info.code(), 'A');
+    EXPECT_TRUE(matches(atlas, {{2, 4}, 1, location}, bitmapGlyphs[2]));
+
+    // glyph range
+    const GlyphInfo *expected[] = {&bitmapGlyphs[2], &bitmapGlyphs[3], &bitmapGlyphs[0]};
+    int i = 0;
+    for (auto glyph : atlas.glyphRange("ABX")) {
+        EXPECT_TRUE(matches(atlas, glyph, *expected[i]));
+        ++i;
+    }
+    EXPECT_EQ(i, 3);
+
+    // the atlas keeps a copy of the font, e.g. a temporary font returned by OptimizedFont::font()
+    GlyphAtlas copy(LinearFont(bitmapFont), {6, 6});
+    auto c = copy.get('B');
+    EXPECT_TRUE(matches(copy, c, bitmapGlyphs[3]));
+}
+
+TEST(cocoTest, GlyphAtlasStress) {
+    GlyphAtlas atlas(bitmapFont, {9, 9});
+    std::mt19937 random(1);
+    for (int i = 0; i < 1000; ++i) {
+        if (random() % 4 == 0)
+            atlas.nextFrame();
+        auto info = &bitmapGlyphs[random() % std::size(bitmapGlyphs)];
+        auto glyph = atlas.get(info);
+        ASSERT_TRUE(matches(atlas, glyph, *info)) << i;
+        ASSERT_LE(glyph.location.x + glyph.size.x, 9);
+        ASSERT_LE(glyph.location.y + glyph.size.y, 9);
+    }
+}
+
+// font with glyphs of width 3 and different heights and unique bitmap contents
+struct AtlasTestFont {
+    std::vector<uint8_t> data;
+    std::vector<GlyphInfo> glyphs;
+    LinearFont font;
+
+    AtlasTestFont(int count, const std::vector<int> &heights)
+        : data(makeData(count, heights)), glyphs(makeGlyphs(count, heights)),
+        font{1, 16, data.data(), int(data.size()), glyphs.data(), glyphs.data() + glyphs.size()} {}
+
+    static std::vector<uint8_t> makeData(int count, const std::vector<int> &heights) {
+        std::vector<uint8_t> data;
+        for (int i = 0; i < count; ++i) {
+            for (int j = 0; j < 3 * heights[i % heights.size()]; ++j)
+                data.push_back(uint8_t(i * 7 + j + 1));
+        }
+        return data;
+    }
+
+    static std::vector<GlyphInfo> makeGlyphs(int count, const std::vector<int> &heights) {
+        std::vector<GlyphInfo> glyphs;
+        int location = 0;
+        for (int i = 0; i < count; ++i) {
+            int height = heights[i % heights.size()];
+            glyphs.push_back(glyphInfo(i == 0 ? 0 : 0x100 + i, 3, height, location, 0));
+            location += 3 * height;
+        }
+        return glyphs;
+    }
+};
+
+TEST(cocoTest, GlyphAtlasEvictRun) {
+    // glyphs 1-6 are 3 high (shelf of 4 with padding), glyph 7 is 7 high (needs 8)
+    AtlasTestFont test(8, {3, 3, 3, 3, 3, 3, 3, 7});
+    auto &glyphs = test.glyphs;
+
+    // two glyphs per shelf, three shelves fill the texture
+    GlyphAtlas atlas(test.font, {8, 12});
+    for (int i = 1; i <= 6; ++i) {
+        atlas.get(&glyphs[i]);
+        if (i % 2 == 0)
+            atlas.nextFrame();
+    }
+    EXPECT_EQ(atlas.evictionCount(), 0);
+
+    // use the last shelf in the current frame
+    auto g5 = atlas.get(&glyphs[5]);
+    EXPECT_EQ(g5.location.y, 8);
+
+    // tall glyph evicts only the two least recently used shelves
+    auto tall = atlas.get(&glyphs[7]);
+    EXPECT_EQ(atlas.evictionCount(), 2);
+    EXPECT_EQ(tall.location.y, 0);
+    EXPECT_TRUE(matches(atlas, tall, glyphs[7], test.font));
+
+    // glyph of the last shelf is still in place and was not packed again
+    atlas.takeDirty();
+    auto g5b = atlas.get(&glyphs[5]);
+    EXPECT_EQ(g5b.location.x, g5.location.x);
+    EXPECT_EQ(g5b.location.y, g5.location.y);
+    EXPECT_TRUE(atlas.takeDirty().empty());
+    EXPECT_TRUE(matches(atlas, g5b, glyphs[5], test.font));
+}
+
+TEST(cocoTest, GlyphAtlasMixedHeights) {
+    // mostly short glyphs and some tall ones
+    AtlasTestFont test(300, {4, 5, 4, 6, 4, 5, 4, 14, 4, 5, 16});
+    GlyphAtlas atlas(test.font, {64, 64});
+    std::mt19937 random(1);
+    int packs = 0;
+    int moves = 0;
+    std::map<int, int2> frameGlyphs;
+    for (int i = 0; i < 100000; ++i) {
+        if (i % 50 == 0) {
+            atlas.nextFrame();
+            frameGlyphs.clear();
+        }
+
+        // a small working set with occasional other glyphs
+        int index = random() % 8 ? random() % 40 : random() % 300;
+        auto glyph = atlas.get(&test.glyphs[index]);
+        packs += !atlas.takeDirty().empty();
+        ASSERT_TRUE(matches(atlas, glyph, test.glyphs[index], test.font)) << i;
+        ASSERT_LE(glyph.location.y + glyph.size.y, 64);
+
+        // count glyphs that were used in the current frame and moved because their shelf was evicted
+        auto it = frameGlyphs.find(index);
+        if (it != frameGlyphs.end() && (glyph.location.x != it->second.x || glyph.location.y != it->second.y))
+            ++moves;
+        frameGlyphs[index] = glyph.location;
+    }
+
+    // a tall glyph that fits into no shelf evicts only the least recently used run of shelves. Evicting the whole
+    // texture instead needs 14605 packs and moves 541 glyphs of the current frame
+    EXPECT_LT(packs, 14000);
+    EXPECT_LT(moves, 500);
+}
+
+TEST(cocoTest, BatchMeasure) {
+    // table with 3 columns, some cells contain non-ASCII or invalid UTF-8
+    const char *pieces[] = {"a", "A", "xbc", " ", "X", "Ö", "⺷", "😊", "\xC3", "0123456789"};
+    std::mt19937 random(1);
+    std::vector<std::string> cells;
+    for (int i = 0; i < 3000; ++i) {
+        std::string cell;
+        int n = random() % 20;
+        for (int j = 0; j < n; ++j)
+            cell += pieces[random() % (i % 2 ? 5 : std::size(pieces))];
+        cells.push_back(cell);
+    }
+    std::vector<String> texts;
+    for (auto &cell : cells)
+        texts.emplace_back(cell.data(), int(cell.size()));
+
+    std::vector<int> expected(texts.size());
+    std::vector<int> expectedColumns(3);
+    for (int i = 0; i < int(texts.size()); ++i) {
+        expected[i] = proportionalFont.calcWidth(texts[i]);
+        expectedColumns[i % 3] = std::max(expectedColumns[i % 3], expected[i]);
+    }
+
+    for (int threadCount : {1, 4}) {
+        BatchMeasure batch(threadCount);
+        EXPECT_EQ(batch.threadCount(), threadCount);
+        std::vector<int> widths(texts.size());
+        auto columns = batch.calcWidths(proportionalFont, texts, widths, 3);
+        EXPECT_EQ(widths, expected);
+        EXPECT_EQ(columns, expectedColumns);
+
+        // monospace font (no fast path)
+        std::vector<int> expectedMonospace(texts.size());
+        int expectedMax = 0;
+        for (int i = 0; i < int(texts.size()); ++i) {
+            expectedMonospace[i] = monospaceFont.calcWidth(texts[i]);
+            expectedMax = std::max(expectedMax, expectedMonospace[i]);
+        }
+        columns = batch.calcWidths(monospaceFont, texts, widths);
+        EXPECT_EQ(widths, expectedMonospace);
+        EXPECT_EQ(columns, std::vector<int>({expectedMax}));
+
+        // many columns span several cache lines
+        std::vector<int> expected40(40);
+        for (int i = 0; i < int(texts.size()); ++i)
+            expected40[i % 40] = std::max(expected40[i % 40], expected[i]);
+        EXPECT_EQ(batch.calcWidths(proportionalFont, texts, widths, 40), expected40);
+
+        // invalid column count
+        EXPECT_TRUE(batch.calcWidths(proportionalFont, texts, widths, 0).empty());
+
+        // output span with wrong size is not written
+        std::vector<int> shortWidths(texts.size() - 1, -1);
+        EXPECT_TRUE(batch.calcWidths(proportionalFont, texts, shortWidths).empty());
+        EXPECT_EQ(shortWidths, std::vector<int>(texts.size() - 1, -1));
+    }
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     int success = RUN_ALL_TESTS();